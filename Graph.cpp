@@ -2,11 +2,53 @@
 #include <queue>
 #include <limits>
 #include <algorithm>
+#include <vector>
+
+namespace {
+
+void appendVarint(QByteArray& stream, quint32 value) {
+    while (value >= 0x80) {
+        stream.append(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    stream.append(static_cast<char>(value));
+}
+
+int varintLength(quint32 value) {
+    int length = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++length;
+    }
+    return length;
+}
+
+quint32 zigzagEncode(qint32 value) {
+    return (static_cast<quint32>(value) << 1) ^ static_cast<quint32>(value >> 31);
+}
+
+quint64 interleaveBits(quint32 x, quint32 y) {
+    quint64 key = 0;
+    for (int bit = 0; bit < 16; ++bit) {
+        key |= static_cast<quint64>((x >> bit) & 1) << (2 * bit);
+        key |= static_cast<quint64>((y >> bit) & 1) << (2 * bit + 1);
+    }
+    return key;
+}
+
+bool isSmallInteger(double weight) {
+    return weight >= 0 && weight <= std::numeric_limits<quint32>::max() && weight == std::floor(weight);
+}
 
-Graph::Graph() {
+}
+
+Graph::Graph() : edgeLayout(AdjacencyEdges), edgeCount(0) {
 }
 
 void Graph::addNode(int id, double lat, double lon) {
+    if (edgeLayout != AdjacencyEdges && indexOf(id) == -1) {
+        unpackEdges();
+    }
     GraphNode node;
     node.id = id;
     node.latitude = lat;
@@ -15,10 +57,14 @@ void Graph::addNode(int id, double lat, double lon) {
 }
 
 void Graph::addEdge(int from, int to, double weight) {
+    if (edgeLayout != AdjacencyEdges) {
+        unpackEdges();
+    }
     Edge edge;
     edge.to = to;
     edge.weight = weight;
     adjacencyList[from].append(edge);
+    ++edgeCount;
 }
 
 double Graph::calculateDistance(double lat1, double lon1, double lat2, double lon2) {
@@ -28,6 +74,10 @@ double Graph::calculateDistance(double lat1, double lon1, double lat2, double lo
 }
 
 QVector<int> Graph::dijkstra(int start, int end) {
+    if (edgeLayout != AdjacencyEdges) {
+        return dijkstraPacked(start, end);
+    }
+
     QMap<int, double> distances;
     QMap<int, int> previous;
     QMap<int, bool> visited;
@@ -82,10 +132,270 @@ QVector<int> Graph::dijkstra(int start, int end) {
     return path;
 }
 
-const QMap<int, GraphNode>& Graph::getNodes() const {
-    return nodes;
+QVector<int> Graph::dijkstraPacked(int start, int end) const {
+    int source = indexOf(start);
+    int target = indexOf(end);
+    if (source == -1 || target == -1) {
+        return QVector<int>();
+    }
+
+    int count = indexToId.size();
+
+    std::vector<double> distances(count, std::numeric_limits<double>::infinity());
+    std::vector<int> previous(count, -1);
+    std::vector<bool> visited(count, false);
+    distances[source] = 0;
+
+    std::priority_queue<QPair<double, int>, std::vector<QPair<double, int>>, std::greater<QPair<double, int>>> pq;
+    pq.push(qMakePair(0.0, source));
+
+    while (!pq.empty()) {
+        int current = pq.top().second;
+        pq.pop();
+
+        if (visited[current]) continue;
+        visited[current] = true;
+
+        if (current == target) break;
+
+        double currentDist = distances[current];
+        visitPackedEdges(current, [&](int neighbour, double weight) {
+            if (!visited[neighbour]) {
+                double newDist = currentDist + weight;
+                if (newDist < distances[neighbour]) {
+                    distances[neighbour] = newDist;
+                    previous[neighbour] = current;
+                    pq.push(qMakePair(newDist, neighbour));
+                }
+            }
+        });
+    }
+
+    QVector<int> path;
+    if (distances[target] == std::numeric_limits<double>::infinity()) {
+        return path;
+    }
+
+    for (int current = target; current != -1; current = previous[current]) {
+        path.append(indexToId[current]);
+    }
+    std::reverse(path.begin(), path.end());
+
+    return path;
 }
 
-const QMap<int, QVector<Edge>>& Graph::getAdjacencyList() const {
-    return adjacencyList;
+double Graph::calculatePathLength(const QVector<int>& path) const {
+    double length = 0;
+    for (int i = 0; i + 1 < path.size(); ++i) {
+        double best = std::numeric_limits<double>::infinity();
+        forEachEdge(path[i], [&](const Edge& edge) {
+            if (edge.to == path[i + 1] && edge.weight < best) {
+                best = edge.weight;
+            }
+        });
+        length += best;
+    }
+    return length;
+}
+
+QVector<int> Graph::computeRenumbering() const {
+    double minLat = std::numeric_limits<double>::max();
+    double maxLat = std::numeric_limits<double>::lowest();
+    double minLon = std::numeric_limits<double>::max();
+    double maxLon = std::numeric_limits<double>::lowest();
+    for (auto it = nodes.begin(); it != nodes.end(); ++it) {
+        minLat = std::min(minLat, it.value().latitude);
+        maxLat = std::max(maxLat, it.value().latitude);
+        minLon = std::min(minLon, it.value().longitude);
+        maxLon = std::max(maxLon, it.value().longitude);
+    }
+
+    double latRange = maxLat - minLat;
+    double lonRange = maxLon - minLon;
+    if (latRange <= 0) latRange = 1.0;
+    if (lonRange <= 0) lonRange = 1.0;
+
+    QVector<QPair<quint64, int>> keyed;
+    keyed.reserve(nodes.size());
+    for (auto it = nodes.begin(); it != nodes.end(); ++it) {
+        quint32 x = static_cast<quint32>((it.value().latitude - minLat) / latRange * 65535.0);
+        quint32 y = static_cast<quint32>((it.value().longitude - minLon) / lonRange * 65535.0);
+        keyed.append(qMakePair(interleaveBits(x, y), it.key()));
+    }
+    std::sort(keyed.begin(), keyed.end());
+
+    QVector<int> order;
+    order.reserve(keyed.size());
+    for (const auto& entry : keyed) {
+        order.append(entry.second);
+    }
+    return order;
+}
+
+void Graph::collectTargets(int index, QVector<QPair<int, double>>& targets) const {
+    targets.clear();
+    auto found = adjacencyList.constFind(indexToId[index]);
+    if (found == adjacencyList.constEnd()) {
+        return;
+    }
+    for (const Edge& edge : found.value()) {
+        int target = indexOf(edge.to);
+        if (target != -1) {
+            targets.append(qMakePair(target, edge.weight));
+        }
+    }
+    std::sort(targets.begin(), targets.end());
+}
+
+bool Graph::packEdges(EdgeLayout layout) {
+    if (layout == edgeLayout) {
+        return true;
+    }
+    if (edgeLayout != AdjacencyEdges) {
+        unpackEdges();
+    }
+    if (layout == AdjacencyEdges) {
+        return true;
+    }
+
+    QVector<int> order = computeRenumbering();
+    QVector<int> indices(order.size());
+    for (int i = 0; i < indices.size(); ++i) {
+        indices[i] = i;
+    }
+    std::sort(indices.begin(), indices.end(), [&](int a, int b) {
+        return order[a] < order[b];
+    });
+    QVector<int> ids(order.size());
+    for (int i = 0; i < ids.size(); ++i) {
+        ids[i] = order[indices[i]];
+    }
+
+    indexToId = order;
+    sortedIds = ids;
+    sortedIndices = indices;
+
+    qint64 keptEdges = 0;
+    qint64 streamBytes = 0;
+    bool fits = true;
+    QVector<QPair<int, double>> targets;
+    for (int i = 0; i < order.size() && fits; ++i) {
+        collectTargets(i, targets);
+        keptEdges += targets.size();
+        if (layout != CompressedEdges) continue;
+
+        int previousTarget = i;
+        for (int j = 0; j < targets.size(); ++j) {
+            if (!isSmallInteger(targets[j].second)) {
+                fits = false;
+                break;
+            }
+            int delta = targets[j].first - previousTarget;
+            streamBytes += varintLength(j == 0 ? zigzagEncode(delta) : static_cast<quint32>(delta));
+            streamBytes += varintLength(static_cast<quint32>(targets[j].second));
+            previousTarget = targets[j].first;
+        }
+    }
+    qint64 packedBytes = layout == CompressedEdges ? streamBytes : keptEdges * static_cast<qint64>(sizeof(Edge));
+    if (!fits || packedBytes > maxPackedBytes) {
+        indexToId.clear();
+        sortedIds.clear();
+        sortedIndices.clear();
+        return false;
+    }
+
+    QVector<quint32> offsets;
+    offsets.reserve(order.size() + 1);
+    QByteArray stream;
+    QVector<Edge> packed;
+    if (layout == CompressedEdges) {
+        stream.reserve(static_cast<int>(streamBytes));
+    } else {
+        packed.reserve(static_cast<int>(keptEdges));
+    }
+
+    for (int i = 0; i < order.size(); ++i) {
+        offsets.append(static_cast<quint32>(layout == CompressedEdges ? stream.size() : packed.size()));
+        collectTargets(i, targets);
+        adjacencyList.remove(order[i]);
+
+        int previousTarget = i;
+        for (int j = 0; j < targets.size(); ++j) {
+            if (layout == CompressedEdges) {
+                int delta = targets[j].first - previousTarget;
+                appendVarint(stream, j == 0 ? zigzagEncode(delta) : static_cast<quint32>(delta));
+                appendVarint(stream, static_cast<quint32>(targets[j].second));
+                previousTarget = targets[j].first;
+            } else {
+                Edge edge;
+                edge.to = targets[j].first;
+                edge.weight = targets[j].second;
+                packed.append(edge);
+            }
+        }
+    }
+    offsets.append(static_cast<quint32>(layout == CompressedEdges ? stream.size() : packed.size()));
+    adjacencyList.clear();
+
+    edgeOffsets = offsets;
+    edgeStream = stream;
+    packedEdges = packed;
+    edgeCount = keptEdges;
+    edgeLayout = layout;
+
+    return true;
+}
+
+void Graph::unpackEdges() {
+    QMap<int, QVector<Edge>> rebuilt;
+    forEachEdge([&](int from, const Edge& edge) {
+        rebuilt[from].append(edge);
+    });
+
+    adjacencyList = rebuilt;
+    edgeLayout = AdjacencyEdges;
+    indexToId.clear();
+    sortedIds.clear();
+    sortedIndices.clear();
+    edgeOffsets.clear();
+    packedEdges.clear();
+    edgeStream.clear();
+}
+
+Graph::EdgeLayout Graph::getEdgeLayout() const {
+    return edgeLayout;
+}
+
+int Graph::indexOf(int id) const {
+    auto found = std::lower_bound(sortedIds.constBegin(), sortedIds.constEnd(), id);
+    if (found == sortedIds.constEnd() || *found != id) {
+        return -1;
+    }
+    return sortedIndices[static_cast<int>(found - sortedIds.constBegin())];
+}
+
+qint64 Graph::getEdgeCount() const {
+    return edgeCount;
+}
+
+qint64 Graph::getEdgeStorageBytes() const {
+    if (edgeLayout != AdjacencyEdges) {
+        return edgeStream.capacity()
+            + static_cast<qint64>(packedEdges.capacity()) * sizeof(Edge)
+            + static_cast<qint64>(edgeOffsets.capacity()) * sizeof(quint32)
+            + static_cast<qint64>(indexToId.capacity()) * sizeof(int)
+            + static_cast<qint64>(sortedIds.capacity()) * sizeof(int)
+            + static_cast<qint64>(sortedIndices.capacity()) * sizeof(int);
+    }
+
+    qint64 bytes = 0;
+    for (auto it = adjacencyList.begin(); it != adjacencyList.end(); ++it) {
+        bytes += sizeof(QMapNode<int, QVector<Edge>>) + sizeof(QArrayData);
+        bytes += static_cast<qint64>(it.value().capacity()) * sizeof(Edge);
+    }
+    return bytes;
+}
+
+const QMap<int, GraphNode>& Graph::getNodes() const {
+    return nodes;
 }
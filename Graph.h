@@ -4,6 +4,8 @@
 #include <QMap>
 #include <QVector>
 #include <QPair>
+#include <QByteArray>
+#include <algorithm>
 #include <cmath>
 
 struct GraphNode {
@@ -19,17 +21,135 @@ struct Edge {
 
 class Graph {
 public:
+    enum EdgeLayout {
+        AdjacencyEdges,
+        PackedEdges,
+        CompressedEdges
+    };
+
+    static constexpr qint64 maxPackedBytes = 0x7FFFF000;
+
     Graph();
     void addNode(int id, double lat, double lon);
     void addEdge(int from, int to, double weight);
     QVector<int> dijkstra(int start, int end);
+    double calculatePathLength(const QVector<int>& path) const;
+    bool packEdges(EdgeLayout layout);
+    EdgeLayout getEdgeLayout() const;
+    qint64 getEdgeCount() const;
+    qint64 getEdgeStorageBytes() const;
     const QMap<int, GraphNode>& getNodes() const;
-    const QMap<int, QVector<Edge>>& getAdjacencyList() const;
+
+    template <typename Visitor>
+    void forEachEdge(Visitor visit) const;
+    template <typename Visitor>
+    void forEachEdge(int from, Visitor visit) const;
 
 private:
     QMap<int, GraphNode> nodes;
     QMap<int, QVector<Edge>> adjacencyList;
+    EdgeLayout edgeLayout;
+    QVector<int> indexToId;
+    QVector<int> sortedIds;
+    QVector<int> sortedIndices;
+    QVector<quint32> edgeOffsets;
+    QVector<Edge> packedEdges;
+    QByteArray edgeStream;
+    qint64 edgeCount;
     double calculateDistance(double lat1, double lon1, double lat2, double lon2);
+    int indexOf(int id) const;
+    QVector<int> computeRenumbering() const;
+    QVector<int> dijkstraPacked(int start, int end) const;
+    void collectTargets(int index, QVector<QPair<int, double>>& targets) const;
+    void unpackEdges();
+    template <typename Visitor>
+    void visitPackedEdges(int index, Visitor visit) const;
+
+    static quint32 readVarint(const uchar*& cursor) {
+        quint32 value = 0;
+        int shift = 0;
+        while (*cursor & 0x80) {
+            value |= static_cast<quint32>(*cursor & 0x7F) << shift;
+            shift += 7;
+            ++cursor;
+        }
+        value |= static_cast<quint32>(*cursor) << shift;
+        ++cursor;
+        return value;
+    }
+
+    static qint32 zigzagDecode(quint32 value) {
+        return static_cast<qint32>(value >> 1) ^ -static_cast<qint32>(value & 1);
+    }
 };
 
+template <typename Visitor>
+void Graph::visitPackedEdges(int index, Visitor visit) const {
+    if (edgeLayout == PackedEdges) {
+        for (quint32 i = edgeOffsets[index]; i < edgeOffsets[index + 1]; ++i) {
+            visit(packedEdges[i].to, packedEdges[i].weight);
+        }
+        return;
+    }
+
+    const uchar* stream = reinterpret_cast<const uchar*>(edgeStream.constData());
+    const uchar* cursor = stream + edgeOffsets[index];
+    const uchar* limit = stream + edgeOffsets[index + 1];
+
+    int neighbour = index;
+    bool first = true;
+    while (cursor < limit) {
+        quint32 delta = readVarint(cursor);
+        neighbour = first ? neighbour + zigzagDecode(delta) : neighbour + static_cast<int>(delta);
+        first = false;
+        visit(neighbour, static_cast<double>(readVarint(cursor)));
+    }
+}
+
+template <typename Visitor>
+void Graph::forEachEdge(Visitor visit) const {
+    if (edgeLayout == AdjacencyEdges) {
+        for (auto it = adjacencyList.begin(); it != adjacencyList.end(); ++it) {
+            for (const Edge& edge : it.value()) {
+                visit(it.key(), edge);
+            }
+        }
+        return;
+    }
+
+    for (int i = 0; i < indexToId.size(); ++i) {
+        int from = indexToId[i];
+        visitPackedEdges(i, [&](int neighbour, double weight) {
+            Edge edge;
+            edge.to = indexToId[neighbour];
+            edge.weight = weight;
+            visit(from, edge);
+        });
+    }
+}
+
+template <typename Visitor>
+void Graph::forEachEdge(int from, Visitor visit) const {
+    if (edgeLayout == AdjacencyEdges) {
+        auto found = adjacencyList.constFind(from);
+        if (found != adjacencyList.constEnd()) {
+            for (const Edge& edge : found.value()) {
+                visit(edge);
+            }
+        }
+        return;
+    }
+
+    int index = indexOf(from);
+    if (index == -1) {
+        return;
+    }
+    visitPackedEdges(index, [&](int neighbour, double weight) {
+        Edge edge;
+        edge.to = indexToId[neighbour];
+        edge.weight = weight;
+        visit(edge);
+    });
+}
+
 #endif
@@ -1,11 +1,12 @@
 #include "MainWindow.h"
 #include <QDebug>
+#include <QStatusBar>
 #include <limits>
 
 MainWindow::MainWindow(Graph* g, KDTree* kd, QWidget* parent)
-    : QMainWindow(parent), graph(g), kdtree(kd), 
-      scale(1.0), offsetX(0), offsetY(0), zoomFactor(1.0),
-      selectedNode1(-1), selectedNode2(-1) {
+    : QMainWindow(parent), graph(g), kdtree(kd), tiles(nullptr),
+      scale(1.0), offsetX(0), offsetY(0), panX(0), panY(0), zoomFactor(1.0),
+      selectedNode1(-1), selectedNode2(-1), selectedCell1(-1), selectedCell2(-1) {
     
     setWindowTitle("Dijkstra Path Visualizer - Luxembourg Map");
     resize(1200, 800);
@@ -14,10 +15,31 @@ MainWindow::MainWindow(Graph* g, KDTree* kd, QWidget* parent)
     updateScale();
 }
 
+MainWindow::MainWindow(TileStore* t, QWidget* parent)
+    : QMainWindow(parent), graph(nullptr), kdtree(nullptr), tiles(t),
+      scale(1.0), offsetX(0), offsetY(0), panX(0), panY(0), zoomFactor(1.0),
+      selectedNode1(-1), selectedNode2(-1), selectedCell1(-1), selectedCell2(-1) {
+    
+    setWindowTitle("Dijkstra Path Visualizer - Tiled Map");
+    resize(1200, 800);
+    
+    calculateBounds();
+    updateScale();
+}
+
 MainWindow::~MainWindow() {
 }
 
 void MainWindow::calculateBounds() {
+    if (tiles) {
+        const TileBounds& bounds = tiles->getLayout().bounds;
+        minLat = bounds.minLat;
+        maxLat = bounds.maxLat;
+        minLon = bounds.minLon;
+        maxLon = bounds.maxLon;
+        return;
+    }
+    
     minLat = std::numeric_limits<double>::max();
     maxLat = std::numeric_limits<double>::lowest();
     minLon = std::numeric_limits<double>::max();
@@ -42,8 +64,8 @@ void MainWindow::updateScale() {
     
     scale = std::min(scaleX, scaleY) * zoomFactor;
     
-    offsetX = 20;
-    offsetY = 20;
+    offsetX = 20 + panX;
+    offsetY = 20 + panY;
 }
 
 QPointF MainWindow::mapToScreen(double lat, double lon) {
@@ -58,85 +80,171 @@ QPair<double, double> MainWindow::screenToMap(int x, int y) {
     return qMakePair(lat, lon);
 }
 
+void MainWindow::drawGraph(QPainter& painter) {
+    const QMap<int, GraphNode>& nodes = graph->getNodes();
+    
+    bool started = false;
+    int fromId = 0;
+    bool fromKnown = false;
+    QPointF fromPoint;
+    graph->forEachEdge([&](int from, const Edge& edge) {
+        if (!started || from != fromId) {
+            started = true;
+            fromId = from;
+            auto fromNode = nodes.constFind(from);
+            fromKnown = fromNode != nodes.constEnd();
+            if (fromKnown) {
+                fromPoint = mapToScreen(fromNode.value().latitude, fromNode.value().longitude);
+            }
+        }
+        if (!fromKnown) return;
+        
+        auto toNode = nodes.constFind(edge.to);
+        if (toNode == nodes.constEnd()) return;
+        
+        QPointF toPoint = mapToScreen(toNode.value().latitude, toNode.value().longitude);
+        painter.drawLine(fromPoint, toPoint);
+    });
+}
+
+void MainWindow::drawTiles(QPainter& painter) {
+    QPair<double, double> topLeft = screenToMap(0, 0);
+    QPair<double, double> bottomRight = screenToMap(width(), height());
+    QVector<int> visibleCells = tiles->getCellsInRange(bottomRight.first, topLeft.first,
+                                                       topLeft.second, bottomRight.second);
+    
+    if (visibleCells.size() > tiles->getMaxResidentCells()) {
+        const QVector<TileBounds>& cellBounds = tiles->getLayout().cellBounds;
+        for (int cell : visibleCells) {
+            const TileBounds& bounds = cellBounds[cell];
+            painter.drawRect(QRectF(mapToScreen(bounds.maxLat, bounds.minLon),
+                                    mapToScreen(bounds.minLat, bounds.maxLon)));
+        }
+        return;
+    }
+    
+    for (int cell : visibleCells) {
+        std::shared_ptr<TileCell> tile = tiles->getCell(cell);
+        if (!tile) continue;
+        
+        for (int i = 0; i < tile->getNodeCount(); ++i) {
+            const TileNodeRecord& fromNode = tile->getNode(i);
+            QPointF fromPoint = mapToScreen(fromNode.latitude, fromNode.longitude);
+            
+            for (const TileEdgeRecord* edge = tile->edgesBegin(i); edge != tile->edgesEnd(i); ++edge) {
+                QPointF toPoint = mapToScreen(edge->latitude, edge->longitude);
+                painter.drawLine(fromPoint, toPoint);
+            }
+        }
+    }
+}
+
 void MainWindow::paintEvent(QPaintEvent* event) {
     QPainter painter(this);
     painter.setRenderHint(QPainter::Antialiasing);
     
     painter.fillRect(rect(), Qt::white);
     
-    const QMap<int, QVector<Edge>>& adjacencyList = graph->getAdjacencyList();
-    const QMap<int, GraphNode>& nodes = graph->getNodes();
-    
     painter.setPen(QPen(QColor(200, 200, 200), 1));
-    for (auto it = adjacencyList.begin(); it != adjacencyList.end(); ++it) {
-        int fromId = it.key();
-        if (!nodes.contains(fromId)) continue;
-        
-        const GraphNode& fromNode = nodes[fromId];
-        QPointF fromPoint = mapToScreen(fromNode.latitude, fromNode.longitude);
-        
-        for (const Edge& edge : it.value()) {
-            if (!nodes.contains(edge.to)) continue;
-            
-            const GraphNode& toNode = nodes[edge.to];
-            QPointF toPoint = mapToScreen(toNode.latitude, toNode.longitude);
-            
-            painter.drawLine(fromPoint, toPoint);
-        }
+    if (tiles) {
+        drawTiles(painter);
+    } else {
+        drawGraph(painter);
     }
     
     if (!shortestPath.isEmpty()) {
         painter.setPen(QPen(Qt::red, 3));
         for (int i = 0; i < shortestPath.size() - 1; ++i) {
-            int fromId = shortestPath[i];
-            int toId = shortestPath[i + 1];
+            const GraphNode& fromNode = shortestPath[i];
+            const GraphNode& toNode = shortestPath[i + 1];
             
-            if (nodes.contains(fromId) && nodes.contains(toId)) {
-                const GraphNode& fromNode = nodes[fromId];
-                const GraphNode& toNode = nodes[toId];
-                
-                QPointF fromPoint = mapToScreen(fromNode.latitude, fromNode.longitude);
-                QPointF toPoint = mapToScreen(toNode.latitude, toNode.longitude);
-                
-                painter.drawLine(fromPoint, toPoint);
-            }
+            QPointF fromPoint = mapToScreen(fromNode.latitude, fromNode.longitude);
+            QPointF toPoint = mapToScreen(toNode.latitude, toNode.longitude);
+            
+            painter.drawLine(fromPoint, toPoint);
         }
     }
     
-    if (selectedNode1 != -1 && nodes.contains(selectedNode1)) {
-        const GraphNode& node = nodes[selectedNode1];
-        QPointF point = mapToScreen(node.latitude, node.longitude);
+    if (selectedNode1 != -1) {
+        QPointF point = mapToScreen(startNode.latitude, startNode.longitude);
         painter.setBrush(Qt::green);
         painter.setPen(QPen(Qt::darkGreen, 2));
         painter.drawEllipse(point, 6, 6);
     }
     
-    if (selectedNode2 != -1 && nodes.contains(selectedNode2)) {
-        const GraphNode& node = nodes[selectedNode2];
-        QPointF point = mapToScreen(node.latitude, node.longitude);
+    if (selectedNode2 != -1) {
+        QPointF point = mapToScreen(endNode.latitude, endNode.longitude);
         painter.setBrush(Qt::blue);
         painter.setPen(QPen(Qt::darkBlue, 2));
         painter.drawEllipse(point, 6, 6);
     }
 }
 
+bool MainWindow::findNearestNode(double lat, double lon, GraphNode& node, int& cell) {
+    if (tiles) {
+        bool found = tiles->findNearest(lat, lon, node, cell);
+        reportLoadError();
+        return found;
+    }
+    
+    int nearestNode = kdtree->findNearest(lat, lon);
+    if (nearestNode == -1 || !graph->getNodes().contains(nearestNode)) {
+        return false;
+    }
+    node = graph->getNodes()[nearestNode];
+    cell = -1;
+    return true;
+}
+
+QVector<GraphNode> MainWindow::findShortestPath() {
+    if (tiles) {
+        QVector<GraphNode> path = tiles->dijkstra(selectedNode1, selectedCell1, selectedNode2, selectedCell2);
+        reportLoadError();
+        return path;
+    }
+    
+    QVector<GraphNode> path;
+    const QMap<int, GraphNode>& nodes = graph->getNodes();
+    for (int id : graph->dijkstra(selectedNode1, selectedNode2)) {
+        if (nodes.contains(id)) {
+            path.append(nodes[id]);
+        }
+    }
+    return path;
+}
+
+void MainWindow::reportLoadError() {
+    if (tiles->getLoadError().isEmpty()) {
+        statusBar()->clearMessage();
+        return;
+    }
+    qDebug() << tiles->getLoadError();
+    statusBar()->showMessage(tiles->getLoadError());
+}
+
 void MainWindow::mousePressEvent(QMouseEvent* event) {
+    if (event->button() == Qt::RightButton) {
+        lastDragPos = event->pos();
+        return;
+    }
+    
     if (event->button() == Qt::LeftButton) {
         QPair<double, double> mapCoords = screenToMap(event->x(), event->y());
-        int nearestNode = kdtree->findNearest(mapCoords.first, mapCoords.second);
+        GraphNode nearest;
+        int cell;
         
-        if (nearestNode != -1) {
-            if (selectedNode1 == -1) {
-                selectedNode1 = nearestNode;
+        if (findNearestNode(mapCoords.first, mapCoords.second, nearest, cell)) {
+            if (selectedNode1 == -1 || selectedNode2 != -1) {
+                selectedNode1 = nearest.id;
+                selectedCell1 = cell;
+                startNode = nearest;
                 selectedNode2 = -1;
                 shortestPath.clear();
-            } else if (selectedNode2 == -1) {
-                selectedNode2 = nearestNode;
-                shortestPath = graph->dijkstra(selectedNode1, selectedNode2);
             } else {
-                selectedNode1 = nearestNode;
-                selectedNode2 = -1;
-                shortestPath.clear();
+                selectedNode2 = nearest.id;
+                selectedCell2 = cell;
+                endNode = nearest;
+                shortestPath = findShortestPath();
             }
             
             update();
@@ -144,6 +252,17 @@ void MainWindow::mousePressEvent(QMouseEvent* event) {
     }
 }
 
+void MainWindow::mouseMoveEvent(QMouseEvent* event) {
+    if (event->buttons() & Qt::RightButton) {
+        panX += event->x() - lastDragPos.x();
+        panY += event->y() - lastDragPos.y();
+        lastDragPos = event->pos();
+        
+        updateScale();
+        update();
+    }
+}
+
 void MainWindow::wheelEvent(QWheelEvent* event) {
     double delta = event->angleDelta().y() / 120.0;
     double zoomChange = 1.0 + (delta * 0.1);
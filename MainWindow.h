@@ -7,35 +7,50 @@
 #include <QWheelEvent>
 #include "Graph.h"
 #include "KDTree.h"
+#include "TileStore.h"
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
 
 public:
     MainWindow(Graph* graph, KDTree* kdtree, QWidget* parent = nullptr);
+    MainWindow(TileStore* tiles, QWidget* parent = nullptr);
     ~MainWindow();
 
 protected:
     void paintEvent(QPaintEvent* event) override;
     void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
     void wheelEvent(QWheelEvent* event) override;
     void resizeEvent(QResizeEvent* event) override;
 
 private:
     Graph* graph;
     KDTree* kdtree;
+    TileStore* tiles;
     
     double minLat, maxLat, minLon, maxLon;
     double scale;
     double offsetX, offsetY;
+    double panX, panY;
     double zoomFactor;
+    QPoint lastDragPos;
     
     int selectedNode1;
     int selectedNode2;
-    QVector<int> shortestPath;
+    int selectedCell1;
+    int selectedCell2;
+    GraphNode startNode;
+    GraphNode endNode;
+    QVector<GraphNode> shortestPath;
     
     void calculateBounds();
     void updateScale();
+    void drawGraph(QPainter& painter);
+    void drawTiles(QPainter& painter);
+    bool findNearestNode(double lat, double lon, GraphNode& node, int& cell);
+    QVector<GraphNode> findShortestPath();
+    void reportLoadError();
     QPointF mapToScreen(double lat, double lon);
     QPair<double, double> screenToMap(int x, int y);
 };
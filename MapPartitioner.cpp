@@ -0,0 +1,397 @@
+#include "MapPartitioner.h"
+#include <QDir>
+#include <QFile>
+#include <QDataStream>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <random>
+
+namespace {
+
+const int sampleLimit = 1 << 18;
+const qint64 spillBufferBytes = 8 << 20;
+
+struct SpilledNode {
+    qint32 id;
+    qint32 cell;
+    double latitude;
+    double longitude;
+};
+
+struct SpilledArc {
+    qint32 from;
+    qint32 to;
+    double weight;
+};
+
+struct SourcedArc {
+    qint32 from;
+    qint32 to;
+    qint32 fromCell;
+    qint32 padding;
+    double weight;
+};
+
+struct CellEdge {
+    qint32 from;
+    qint32 padding;
+    TileEdgeRecord edge;
+};
+
+QString spillFileName(const QString& work, const QString& kind, int index) {
+    return QDir(work).filePath(QString("%1_%2.tmp").arg(kind).arg(index));
+}
+
+int bucketOf(int id, int buckets) {
+    return static_cast<int>(static_cast<quint32>(id) % static_cast<quint32>(buckets));
+}
+
+class SpillWriter {
+public:
+    SpillWriter(const QString& work, const QString& kind, int files)
+        : work(work), kind(kind), buffers(files), buffered(0), failed(false) {
+    }
+
+    template <typename T>
+    void append(int index, const T& record) {
+        buffers[index].append(reinterpret_cast<const char*>(&record), sizeof(T));
+        buffered += sizeof(T);
+        if (buffered >= spillBufferBytes) {
+            flush();
+        }
+    }
+
+    bool flush() {
+        for (int i = 0; i < buffers.size(); ++i) {
+            if (buffers[i].isEmpty()) continue;
+            QFile file(spillFileName(work, kind, i));
+            if (!file.open(QIODevice::WriteOnly | QIODevice::Append) ||
+                file.write(buffers[i]) != buffers[i].size()) {
+                failed = true;
+            }
+            buffers[i].clear();
+        }
+        buffered = 0;
+        return !failed;
+    }
+
+private:
+    QString work;
+    QString kind;
+    QVector<QByteArray> buffers;
+    qint64 buffered;
+    bool failed;
+};
+
+template <typename T>
+QVector<T> takeSpill(const QString& filename) {
+    QVector<T> records;
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return records;
+    }
+    QByteArray bytes = file.readAll();
+    file.remove();
+    records.resize(bytes.size() / static_cast<int>(sizeof(T)));
+    std::memcpy(records.data(), bytes.constData(), records.size() * sizeof(T));
+    return records;
+}
+
+QHash<int, SpilledNode> takeNodeBucket(const QString& filename) {
+    QHash<int, SpilledNode> bucket;
+    for (const SpilledNode& node : takeSpill<SpilledNode>(filename)) {
+        bucket.insert(node.id, node);
+    }
+    return bucket;
+}
+
+}
+
+MapPartitioner::MapPartitioner() {
+    layout.bounds.minLat = layout.bounds.maxLat = layout.bounds.minLon = layout.bounds.maxLon = 0;
+    layout.root = TileLayout::childOfCell(0);
+}
+
+bool MapPartitioner::partition(const QString& xmlFilename, const QString& directory, int nodesPerCell) {
+    if (!buildLayout(xmlFilename, nodesPerCell) || !QDir().mkpath(directory)) {
+        return false;
+    }
+
+    QTemporaryDir work(QDir(directory).filePath("partition-XXXXXX"));
+    if (!work.isValid()) {
+        return false;
+    }
+
+    int buckets = layout.cellBounds.size();
+    QVector<qint64> cellBytes;
+    QVector<qint32> cellNodeCounts;
+    return spillMap(xmlFilename, work.path(), buckets) &&
+           resolveSources(work.path(), buckets) &&
+           resolveTargets(work.path(), buckets) &&
+           writeCells(work.path(), directory, cellBytes, cellNodeCounts) &&
+           writeIndex(directory, cellBytes, cellNodeCounts);
+}
+
+bool MapPartitioner::buildLayout(const QString& xmlFilename, int nodesPerCell) {
+    TileBounds bounds;
+    bounds.minLat = std::numeric_limits<double>::max();
+    bounds.maxLat = std::numeric_limits<double>::lowest();
+    bounds.minLon = std::numeric_limits<double>::max();
+    bounds.maxLon = std::numeric_limits<double>::lowest();
+
+    qint64 count = 0;
+    QVector<QPair<double, double>> sample;
+    std::mt19937_64 rng(42);
+
+    bool parsed = XMLParser::streamFile(xmlFilename,
+        [&](const Node& node) {
+            ++count;
+            bounds.minLat = std::min(bounds.minLat, node.latitude);
+            bounds.maxLat = std::max(bounds.maxLat, node.latitude);
+            bounds.minLon = std::min(bounds.minLon, node.longitude);
+            bounds.maxLon = std::max(bounds.maxLon, node.longitude);
+
+            QPair<double, double> point = qMakePair(node.latitude, node.longitude);
+            if (sample.size() < sampleLimit) {
+                sample.append(point);
+            } else {
+                qint64 slot = std::uniform_int_distribution<qint64>(0, count - 1)(rng);
+                if (slot < sampleLimit) {
+                    sample[static_cast<int>(slot)] = point;
+                }
+            }
+        },
+        [](const Arc&) {
+        });
+    if (!parsed || count == 0) {
+        return false;
+    }
+
+    qint64 perCell = std::max(1, nodesPerCell);
+    int cells = static_cast<int>(std::min<qint64>((count + perCell - 1) / perCell, std::numeric_limits<qint32>::max() / 2));
+
+    layout.bounds = bounds;
+    layout.splits.clear();
+    layout.cellBounds.clear();
+    layout.root = buildSplits(sample, 0, sample.size(), cells, 0, bounds);
+    return true;
+}
+
+qint32 MapPartitioner::buildSplits(QVector<QPair<double, double>>& points, int begin, int end,
+                                   int cells, int depth, const TileBounds& bounds) {
+    if (cells == 1) {
+        layout.cellBounds.append(bounds);
+        return TileLayout::childOfCell(layout.cellBounds.size() - 1);
+    }
+
+    int axis = depth % 2;
+    auto coordinate = [axis](const QPair<double, double>& point) {
+        return axis == 0 ? point.first : point.second;
+    };
+
+    int leftCells = cells / 2;
+    int middle = begin + static_cast<int>(static_cast<qint64>(end - begin) * leftCells / cells);
+
+    TileSplit split;
+    split.axis = axis;
+    split.left = 0;
+    split.right = 0;
+    if (middle < end) {
+        std::nth_element(points.begin() + begin, points.begin() + middle, points.begin() + end,
+                         [&](const QPair<double, double>& a, const QPair<double, double>& b) {
+            return coordinate(a) < coordinate(b);
+        });
+        split.value = coordinate(points[middle]);
+    } else {
+        split.value = axis == 0 ? (bounds.minLat + bounds.maxLat) / 2 : (bounds.minLon + bounds.maxLon) / 2;
+    }
+
+    qint32 index = layout.splits.size();
+    layout.splits.append(split);
+
+    qint32 left = buildSplits(points, begin, middle, leftCells, depth + 1,
+                              layout.childBounds(bounds, split, true));
+    qint32 right = buildSplits(points, middle, end, cells - leftCells, depth + 1,
+                               layout.childBounds(bounds, split, false));
+    layout.splits[index].left = left;
+    layout.splits[index].right = right;
+    return index;
+}
+
+bool MapPartitioner::spillMap(const QString& xmlFilename, const QString& work, int buckets) {
+    SpillWriter nodeBuckets(work, "nodes", buckets);
+    SpillWriter cellNodes(work, "cellnodes", layout.cellBounds.size());
+    SpillWriter arcBuckets(work, "arcs", buckets);
+
+    bool parsed = XMLParser::streamFile(xmlFilename,
+        [&](const Node& node) {
+            SpilledNode record;
+            record.id = node.id;
+            record.cell = layout.cellAt(node.latitude, node.longitude);
+            record.latitude = node.latitude;
+            record.longitude = node.longitude;
+            nodeBuckets.append(bucketOf(node.id, buckets), record);
+            cellNodes.append(record.cell, record);
+        },
+        [&](const Arc& arc) {
+            SpilledArc record;
+            record.from = arc.from;
+            record.to = arc.to;
+            record.weight = arc.length;
+            arcBuckets.append(bucketOf(arc.from, buckets), record);
+        });
+
+    bool flushed = nodeBuckets.flush();
+    flushed = cellNodes.flush() && flushed;
+    flushed = arcBuckets.flush() && flushed;
+    return parsed && flushed;
+}
+
+bool MapPartitioner::resolveSources(const QString& work, int buckets) {
+    SpillWriter sourced(work, "sourced", buckets);
+
+    for (int bucket = 0; bucket < buckets; ++bucket) {
+        QFile::copy(spillFileName(work, "nodes", bucket), spillFileName(work, "targets", bucket));
+        QHash<int, SpilledNode> nodes = takeNodeBucket(spillFileName(work, "nodes", bucket));
+
+        for (const SpilledArc& arc : takeSpill<SpilledArc>(spillFileName(work, "arcs", bucket))) {
+            auto found = nodes.constFind(arc.from);
+            if (found == nodes.constEnd()) continue;
+
+            SourcedArc record;
+            record.from = arc.from;
+            record.to = arc.to;
+            record.fromCell = found.value().cell;
+            record.padding = 0;
+            record.weight = arc.weight;
+            sourced.append(bucketOf(arc.to, buckets), record);
+        }
+    }
+
+    return sourced.flush();
+}
+
+bool MapPartitioner::resolveTargets(const QString& work, int buckets) {
+    SpillWriter cellEdges(work, "celledges", layout.cellBounds.size());
+
+    for (int bucket = 0; bucket < buckets; ++bucket) {
+        QHash<int, SpilledNode> nodes = takeNodeBucket(spillFileName(work, "targets", bucket));
+
+        for (const SourcedArc& arc : takeSpill<SourcedArc>(spillFileName(work, "sourced", bucket))) {
+            auto found = nodes.constFind(arc.to);
+            if (found == nodes.constEnd()) continue;
+
+            CellEdge record;
+            record.from = arc.from;
+            record.padding = 0;
+            record.edge.to = arc.to;
+            record.edge.cell = found.value().cell;
+            record.edge.weight = arc.weight;
+            record.edge.latitude = found.value().latitude;
+            record.edge.longitude = found.value().longitude;
+            cellEdges.append(arc.fromCell, record);
+        }
+    }
+
+    return cellEdges.flush();
+}
+
+bool MapPartitioner::writeCells(const QString& work, const QString& directory,
+                                QVector<qint64>& cellBytes, QVector<qint32>& cellNodeCounts) {
+    int cellCount = layout.cellBounds.size();
+    cellBytes.fill(0, cellCount);
+    cellNodeCounts.fill(0, cellCount);
+
+    for (int cell = 0; cell < cellCount; ++cell) {
+        QVector<SpilledNode> spilledNodes = takeSpill<SpilledNode>(spillFileName(work, "cellnodes", cell));
+        QVector<CellEdge> spilledEdges = takeSpill<CellEdge>(spillFileName(work, "celledges", cell));
+        if (spilledNodes.isEmpty()) continue;
+
+        std::stable_sort(spilledNodes.begin(), spilledNodes.end(),
+                         [](const SpilledNode& a, const SpilledNode& b) {
+            return a.id < b.id;
+        });
+        std::stable_sort(spilledEdges.begin(), spilledEdges.end(),
+                         [](const CellEdge& a, const CellEdge& b) {
+            return a.from < b.from;
+        });
+
+        QVector<TileNodeRecord> nodeRecords;
+        QVector<TileEdgeRecord> edgeRecords;
+        int nextEdge = 0;
+        for (int i = 0; i < spilledNodes.size(); ++i) {
+            const SpilledNode& node = spilledNodes[i];
+            if (i + 1 < spilledNodes.size() && spilledNodes[i + 1].id == node.id) continue;
+
+            TileNodeRecord record;
+            record.id = node.id;
+            record.firstEdge = edgeRecords.size();
+            record.latitude = node.latitude;
+            record.longitude = node.longitude;
+            nodeRecords.append(record);
+
+            while (nextEdge < spilledEdges.size() && spilledEdges[nextEdge].from < node.id) ++nextEdge;
+            while (nextEdge < spilledEdges.size() && spilledEdges[nextEdge].from == node.id) {
+                edgeRecords.append(spilledEdges[nextEdge].edge);
+                ++nextEdge;
+            }
+        }
+
+        TileCellHeader header;
+        header.magic = TileStore::cellMagic;
+        header.version = TileStore::cellVersion;
+        header.nodeCount = nodeRecords.size();
+        header.edgeCount = edgeRecords.size();
+
+        QFile file(TileStore::cellFileName(directory, cell));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return false;
+        }
+
+        qint64 expected = sizeof(header)
+            + static_cast<qint64>(nodeRecords.size()) * sizeof(TileNodeRecord)
+            + static_cast<qint64>(edgeRecords.size()) * sizeof(TileEdgeRecord);
+        qint64 written = file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        written += file.write(reinterpret_cast<const char*>(nodeRecords.constData()),
+                              nodeRecords.size() * sizeof(TileNodeRecord));
+        written += file.write(reinterpret_cast<const char*>(edgeRecords.constData()),
+                              edgeRecords.size() * sizeof(TileEdgeRecord));
+        file.close();
+        if (written != expected) {
+            return false;
+        }
+
+        cellBytes[cell] = written;
+        cellNodeCounts[cell] = nodeRecords.size();
+    }
+
+    return true;
+}
+
+bool MapPartitioner::writeIndex(const QString& directory, const QVector<qint64>& cellBytes,
+                                const QVector<qint32>& cellNodeCounts) {
+    QFile file(TileStore::indexFileName(directory));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    QDataStream out(&file);
+    out << TileStore::indexMagic << TileStore::indexVersion;
+    out << layout.bounds << layout.root << static_cast<qint32>(layout.splits.size());
+    for (const TileSplit& split : layout.splits) {
+        out << split;
+    }
+    out << static_cast<qint32>(layout.cellBounds.size());
+    for (int cell = 0; cell < layout.cellBounds.size(); ++cell) {
+        out << layout.cellBounds[cell] << cellBytes[cell] << cellNodeCounts[cell];
+    }
+    file.close();
+
+    return out.status() == QDataStream::Ok;
+}
+
+const TileLayout& MapPartitioner::getLayout() const {
+    return layout;
+}
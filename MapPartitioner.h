@@ -0,0 +1,30 @@
+#ifndef MAPPARTITIONER_H
+#define MAPPARTITIONER_H
+
+#include <QString>
+#include <QVector>
+#include <QPair>
+#include "XMLParser.h"
+#include "TileStore.h"
+
+class MapPartitioner {
+public:
+    MapPartitioner();
+    bool partition(const QString& xmlFilename, const QString& directory, int nodesPerCell);
+    const TileLayout& getLayout() const;
+
+private:
+    TileLayout layout;
+    bool buildLayout(const QString& xmlFilename, int nodesPerCell);
+    qint32 buildSplits(QVector<QPair<double, double>>& points, int begin, int end,
+                       int cells, int depth, const TileBounds& bounds);
+    bool spillMap(const QString& xmlFilename, const QString& work, int buckets);
+    bool resolveSources(const QString& work, int buckets);
+    bool resolveTargets(const QString& work, int buckets);
+    bool writeCells(const QString& work, const QString& directory,
+                    QVector<qint64>& cellBytes, QVector<qint32>& cellNodeCounts);
+    bool writeIndex(const QString& directory, const QVector<qint64>& cellBytes,
+                    const QVector<qint32>& cellNodeCounts);
+};
+
+#endif
@@ -0,0 +1,526 @@
+#include "TileStore.h"
+#include <QDir>
+#include <QSet>
+#include <algorithm>
+#include <limits>
+#include <queue>
+
+namespace {
+
+double squaredDistance(double x1, double y1, double x2, double y2) {
+    double dx = x2 - x1;
+    double dy = y2 - y1;
+    return dx * dx + dy * dy;
+}
+
+template <typename Key, typename T>
+qint64 hashBytes(const QHash<Key, T>& hash) {
+    return static_cast<qint64>(hash.size()) * sizeof(QHashNode<Key, T>)
+        + static_cast<qint64>(hash.capacity()) * sizeof(void*);
+}
+
+}
+
+double TileBounds::squaredDistanceTo(double lat, double lon) const {
+    double dLat = std::max({minLat - lat, 0.0, lat - maxLat});
+    double dLon = std::max({minLon - lon, 0.0, lon - maxLon});
+    return dLat * dLat + dLon * dLon;
+}
+
+bool TileBounds::intersects(const TileBounds& other) const {
+    return minLat <= other.maxLat && other.minLat <= maxLat &&
+           minLon <= other.maxLon && other.minLon <= maxLon;
+}
+
+QDataStream& operator<<(QDataStream& out, const TileBounds& bounds) {
+    return out << bounds.minLat << bounds.maxLat << bounds.minLon << bounds.maxLon;
+}
+
+QDataStream& operator>>(QDataStream& in, TileBounds& bounds) {
+    return in >> bounds.minLat >> bounds.maxLat >> bounds.minLon >> bounds.maxLon;
+}
+
+QDataStream& operator<<(QDataStream& out, const TileSplit& split) {
+    return out << split.axis << split.value << split.left << split.right;
+}
+
+QDataStream& operator>>(QDataStream& in, TileSplit& split) {
+    return in >> split.axis >> split.value >> split.left >> split.right;
+}
+
+bool TileLayout::isCell(qint32 child) {
+    return child < 0;
+}
+
+int TileLayout::cellOf(qint32 child) {
+    return -child - 1;
+}
+
+qint32 TileLayout::childOfCell(int cell) {
+    return -cell - 1;
+}
+
+int TileLayout::cellAt(double lat, double lon) const {
+    qint32 child = root;
+    while (!isCell(child)) {
+        const TileSplit& split = splits[child];
+        double coordinate = split.axis == 0 ? lat : lon;
+        child = coordinate < split.value ? split.left : split.right;
+    }
+    return cellOf(child);
+}
+
+TileBounds TileLayout::childBounds(const TileBounds& parent, const TileSplit& split, bool left) const {
+    TileBounds child = parent;
+    if (split.axis == 0) {
+        (left ? child.maxLat : child.minLat) = split.value;
+    } else {
+        (left ? child.maxLon : child.minLon) = split.value;
+    }
+    return child;
+}
+
+QVector<int> TileLayout::cellsInRange(const TileBounds& range) const {
+    QVector<int> cells;
+    if (cellBounds.isEmpty() || !bounds.intersects(range)) {
+        return cells;
+    }
+
+    QVector<qint32> pending;
+    pending.append(root);
+    while (!pending.isEmpty()) {
+        qint32 child = pending.takeLast();
+        if (isCell(child)) {
+            cells.append(cellOf(child));
+            continue;
+        }
+        const TileSplit& split = splits[child];
+        double low = split.axis == 0 ? range.minLat : range.minLon;
+        double high = split.axis == 0 ? range.maxLat : range.maxLon;
+        if (low < split.value) pending.append(split.left);
+        if (high >= split.value) pending.append(split.right);
+    }
+    return cells;
+}
+
+TileCell::TileCell()
+    : data(nullptr), size(0), header(nullptr), nodes(nullptr), edges(nullptr) {
+}
+
+TileCell::~TileCell() {
+    if (file.isOpen()) {
+        file.close();
+    }
+}
+
+bool TileCell::load(const QString& filename, int expectedNodes, int cellCount) {
+    file.setFileName(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    size = file.size();
+    data = file.map(0, size);
+    if (!data) {
+        buffer = file.readAll();
+        data = reinterpret_cast<const uchar*>(buffer.constData());
+        file.close();
+    }
+
+    if (size < static_cast<qint64>(sizeof(TileCellHeader))) {
+        return false;
+    }
+
+    header = reinterpret_cast<const TileCellHeader*>(data);
+    if (header->magic != TileStore::cellMagic || header->version != TileStore::cellVersion ||
+        header->nodeCount != expectedNodes || header->edgeCount < 0) {
+        return false;
+    }
+
+    qint64 expected = sizeof(TileCellHeader)
+        + static_cast<qint64>(header->nodeCount) * sizeof(TileNodeRecord)
+        + static_cast<qint64>(header->edgeCount) * sizeof(TileEdgeRecord);
+    if (size != expected) {
+        return false;
+    }
+
+    nodes = reinterpret_cast<const TileNodeRecord*>(data + sizeof(TileCellHeader));
+    edges = reinterpret_cast<const TileEdgeRecord*>(nodes + header->nodeCount);
+
+    for (int i = 0; i < header->nodeCount; ++i) {
+        qint32 previousEdge = i > 0 ? nodes[i - 1].firstEdge : 0;
+        if (nodes[i].firstEdge < previousEdge || nodes[i].firstEdge > header->edgeCount ||
+            (i > 0 && nodes[i].id <= nodes[i - 1].id)) {
+            return false;
+        }
+    }
+    for (int i = 0; i < header->edgeCount; ++i) {
+        if (edges[i].cell < 0 || edges[i].cell >= cellCount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int TileCell::getNodeCount() const {
+    return header->nodeCount;
+}
+
+const TileNodeRecord& TileCell::getNode(int index) const {
+    return nodes[index];
+}
+
+int TileCell::findNode(int id) const {
+    const TileNodeRecord* end = nodes + header->nodeCount;
+    const TileNodeRecord* found = std::lower_bound(nodes, end, id,
+        [](const TileNodeRecord& node, int value) {
+            return node.id < value;
+        });
+    if (found == end || found->id != id) {
+        return -1;
+    }
+    return static_cast<int>(found - nodes);
+}
+
+const TileEdgeRecord* TileCell::edgesBegin(int index) const {
+    return edges + nodes[index].firstEdge;
+}
+
+const TileEdgeRecord* TileCell::edgesEnd(int index) const {
+    if (index + 1 < header->nodeCount) {
+        return edges + nodes[index + 1].firstEdge;
+    }
+    return edges + header->edgeCount;
+}
+
+qint64 TileCell::getByteSize() const {
+    return size;
+}
+
+TileStore::TileStore(int maxResident)
+    : maxResidentCells(std::max(1, maxResident)), mappedBytes(0), peakMappedBytes(0),
+      lastSearchBytes(0), cellLoads(0) {
+    layout.bounds.minLat = layout.bounds.maxLat = layout.bounds.minLon = layout.bounds.maxLon = 0;
+    layout.root = TileLayout::childOfCell(0);
+}
+
+QString TileStore::cellFileName(const QString& directory, int cell) {
+    return QDir(directory).filePath(QString("cell_%1.bin").arg(cell));
+}
+
+QString TileStore::indexFileName(const QString& directory) {
+    return QDir(directory).filePath("index.bin");
+}
+
+bool TileStore::open(const QString& dir) {
+    QFile file(indexFileName(dir));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    quint32 magic;
+    qint32 version;
+    in >> magic >> version;
+    if (magic != indexMagic || version != indexVersion) {
+        return false;
+    }
+
+    TileLayout loaded;
+    qint32 splitCount;
+    in >> loaded.bounds >> loaded.root >> splitCount;
+    if (in.status() != QDataStream::Ok || splitCount < 0) {
+        return false;
+    }
+    loaded.splits.resize(splitCount);
+    for (int i = 0; i < splitCount; ++i) {
+        in >> loaded.splits[i];
+    }
+
+    qint32 cellCount;
+    in >> cellCount;
+    if (in.status() != QDataStream::Ok || cellCount <= 0) {
+        return false;
+    }
+    loaded.cellBounds.resize(cellCount);
+    QVector<qint64> bytes(cellCount);
+    QVector<qint32> nodeCounts(cellCount);
+    for (int i = 0; i < cellCount; ++i) {
+        in >> loaded.cellBounds[i] >> bytes[i] >> nodeCounts[i];
+        if (bytes[i] < 0 || nodeCounts[i] < 0) {
+            return false;
+        }
+    }
+    if (in.status() != QDataStream::Ok || !isValidChild(loaded.root, -1, splitCount, cellCount)) {
+        return false;
+    }
+    for (int i = 0; i < splitCount; ++i) {
+        const TileSplit& split = loaded.splits[i];
+        if ((split.axis != 0 && split.axis != 1) ||
+            !isValidChild(split.left, i, splitCount, cellCount) ||
+            !isValidChild(split.right, i, splitCount, cellCount)) {
+            return false;
+        }
+    }
+
+    directory = dir;
+    layout = loaded;
+    cellBytes = bytes;
+    cellNodeCounts = nodeCounts;
+    residentCells.clear();
+    recentCells.clear();
+    mappedBytes = 0;
+    return true;
+}
+
+bool TileStore::isValidChild(qint32 child, int parent, int splitCount, int cellCount) {
+    if (TileLayout::isCell(child)) {
+        return child >= TileLayout::childOfCell(cellCount - 1);
+    }
+    return child > parent && child < splitCount;
+}
+
+void TileStore::evictUnusedCells() {
+    for (int i = recentCells.size() - 1; i >= 0 && residentCells.size() >= maxResidentCells; --i) {
+        int cell = recentCells[i];
+        const std::shared_ptr<TileCell>& tile = residentCells[cell];
+        if (tile.use_count() > 1) continue;
+
+        mappedBytes -= tile->getByteSize();
+        residentCells.remove(cell);
+        recentCells.removeAt(i);
+    }
+}
+
+std::shared_ptr<TileCell> TileStore::getCell(int cell) {
+    if (cell < 0 || cell >= cellNodeCounts.size()) {
+        loadError = QString("Cell %1 is outside the index").arg(cell);
+        return nullptr;
+    }
+    if (cellNodeCounts[cell] == 0) {
+        return nullptr;
+    }
+
+    auto found = residentCells.constFind(cell);
+    if (found != residentCells.constEnd()) {
+        if (recentCells.first() != cell) {
+            recentCells.removeOne(cell);
+            recentCells.prepend(cell);
+        }
+        return found.value();
+    }
+
+    auto tile = std::make_shared<TileCell>();
+    if (!tile->load(cellFileName(directory, cell), cellNodeCounts[cell], cellNodeCounts.size())) {
+        loadError = QString("Failed to load %1").arg(cellFileName(directory, cell));
+        return nullptr;
+    }
+    ++cellLoads;
+
+    evictUnusedCells();
+
+    residentCells.insert(cell, tile);
+    recentCells.prepend(cell);
+    mappedBytes += tile->getByteSize();
+    peakMappedBytes = std::max(peakMappedBytes, mappedBytes);
+    return tile;
+}
+
+int TileStore::getCellAt(double lat, double lon) const {
+    return layout.cellAt(lat, lon);
+}
+
+QVector<int> TileStore::getCellsInRange(double minLat, double maxLat, double minLon, double maxLon) const {
+    TileBounds range;
+    range.minLat = minLat;
+    range.maxLat = maxLat;
+    range.minLon = minLon;
+    range.maxLon = maxLon;
+    return layout.cellsInRange(range);
+}
+
+bool TileStore::findNearest(double lat, double lon, GraphNode& node, int& cell) {
+    loadError.clear();
+    if (layout.cellBounds.isEmpty()) {
+        return false;
+    }
+
+    typedef QPair<double, qint32> Candidate;
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> pending;
+    QHash<qint32, TileBounds> pendingBounds;
+    pending.push(qMakePair(layout.bounds.squaredDistanceTo(lat, lon), layout.root));
+    pendingBounds.insert(layout.root, layout.bounds);
+    double bestDist = std::numeric_limits<double>::infinity();
+
+    while (!pending.empty() && pending.top().first < bestDist) {
+        qint32 child = pending.top().second;
+        pending.pop();
+        TileBounds bounds = pendingBounds.take(child);
+
+        if (!TileLayout::isCell(child)) {
+            const TileSplit& split = layout.splits[child];
+            TileBounds left = layout.childBounds(bounds, split, true);
+            TileBounds right = layout.childBounds(bounds, split, false);
+            pending.push(qMakePair(left.squaredDistanceTo(lat, lon), split.left));
+            pending.push(qMakePair(right.squaredDistanceTo(lat, lon), split.right));
+            pendingBounds.insert(split.left, left);
+            pendingBounds.insert(split.right, right);
+            continue;
+        }
+
+        int index = TileLayout::cellOf(child);
+        std::shared_ptr<TileCell> tile = getCell(index);
+        if (!tile) {
+            if (!loadError.isEmpty()) return false;
+            continue;
+        }
+
+        for (int i = 0; i < tile->getNodeCount(); ++i) {
+            const TileNodeRecord& record = tile->getNode(i);
+            double dist = squaredDistance(lat, lon, record.latitude, record.longitude);
+            if (dist < bestDist) {
+                bestDist = dist;
+                node.id = record.id;
+                node.latitude = record.latitude;
+                node.longitude = record.longitude;
+                cell = index;
+            }
+        }
+    }
+
+    return bestDist != std::numeric_limits<double>::infinity();
+}
+
+QVector<GraphNode> TileStore::dijkstra(int start, int startCell, int end, int endCell) {
+    loadError.clear();
+    QHash<int, double> distances;
+    QHash<int, QPair<int, int>> previous;
+    QSet<int> visited;
+
+    typedef QPair<double, QPair<int, int>> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> pq;
+    size_t peakQueue = 1;
+    distances[start] = 0;
+    pq.push(qMakePair(0.0, qMakePair(start, startCell)));
+
+    while (!pq.empty()) {
+        int current = pq.top().second.first;
+        int cell = pq.top().second.second;
+        pq.pop();
+
+        if (visited.contains(current)) continue;
+        visited.insert(current);
+
+        if (current == end) break;
+
+        std::shared_ptr<TileCell> tile = getCell(cell);
+        if (!tile) {
+            if (loadError.isEmpty()) {
+                loadError = QString("Cell %1 holds no nodes but is reached by node %2").arg(cell).arg(current);
+            }
+            break;
+        }
+        int index = tile->findNode(current);
+        if (index == -1) {
+            loadError = QString("Node %1 is missing from cell %2").arg(current).arg(cell);
+            break;
+        }
+
+        double currentDist = distances.value(current);
+        for (const TileEdgeRecord* edge = tile->edgesBegin(index); edge != tile->edgesEnd(index); ++edge) {
+            if (visited.contains(edge->to)) continue;
+            double newDist = currentDist + edge->weight;
+            auto known = distances.constFind(edge->to);
+            if (known == distances.constEnd() || newDist < known.value()) {
+                distances[edge->to] = newDist;
+                previous[edge->to] = qMakePair(current, cell);
+                pq.push(qMakePair(newDist, qMakePair(edge->to, edge->cell)));
+            }
+        }
+        peakQueue = std::max(peakQueue, pq.size());
+    }
+
+    lastSearchBytes = hashBytes(distances) + hashBytes(previous)
+        + static_cast<qint64>(visited.size()) * sizeof(QHashNode<int, QHashDummyValue>)
+        + static_cast<qint64>(visited.capacity()) * sizeof(void*)
+        + static_cast<qint64>(peakQueue) * sizeof(Entry);
+
+    QVector<GraphNode> path;
+    if (!loadError.isEmpty() || !visited.contains(end)) {
+        return path;
+    }
+
+    QVector<QPair<int, int>> route;
+    QPair<int, int> current = qMakePair(end, endCell);
+    while (current.first != start) {
+        route.append(current);
+        if (!previous.contains(current.first)) {
+            return path;
+        }
+        current = previous.value(current.first);
+    }
+    route.append(qMakePair(start, startCell));
+    std::reverse(route.begin(), route.end());
+
+    for (const auto& step : route) {
+        std::shared_ptr<TileCell> tile = getCell(step.second);
+        int index = tile ? tile->findNode(step.first) : -1;
+        if (index == -1) {
+            if (loadError.isEmpty()) {
+                loadError = QString("Node %1 is missing from cell %2").arg(step.first).arg(step.second);
+            }
+            return QVector<GraphNode>();
+        }
+        GraphNode node;
+        node.id = step.first;
+        node.latitude = tile->getNode(index).latitude;
+        node.longitude = tile->getNode(index).longitude;
+        path.append(node);
+    }
+
+    return path;
+}
+
+const TileLayout& TileStore::getLayout() const {
+    return layout;
+}
+
+int TileStore::getCellCount() const {
+    return cellNodeCounts.size();
+}
+
+int TileStore::getMaxResidentCells() const {
+    return maxResidentCells;
+}
+
+int TileStore::getResidentCellCount() const {
+    return residentCells.size();
+}
+
+int TileStore::getCellLoadCount() const {
+    return cellLoads;
+}
+
+qint64 TileStore::getMappedBytes() const {
+    return mappedBytes;
+}
+
+qint64 TileStore::getPeakMappedBytes() const {
+    return peakMappedBytes;
+}
+
+qint64 TileStore::getLastSearchBytes() const {
+    return lastSearchBytes;
+}
+
+qint64 TileStore::getMapBytes() const {
+    qint64 total = 0;
+    for (qint64 bytes : cellBytes) {
+        total += bytes;
+    }
+    return total;
+}
+
+const QString& TileStore::getLoadError() const {
+    return loadError;
+}
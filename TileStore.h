@@ -0,0 +1,140 @@
+#ifndef TILESTORE_H
+#define TILESTORE_H
+
+#include <QString>
+#include <QFile>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <QDataStream>
+#include <memory>
+#include "Graph.h"
+
+struct TileCellHeader {
+    quint32 magic;
+    qint32 version;
+    qint32 nodeCount;
+    qint32 edgeCount;
+};
+
+struct TileNodeRecord {
+    qint32 id;
+    qint32 firstEdge;
+    double latitude;
+    double longitude;
+};
+
+struct TileEdgeRecord {
+    qint32 to;
+    qint32 cell;
+    double weight;
+    double latitude;
+    double longitude;
+};
+
+struct TileBounds {
+    double minLat;
+    double maxLat;
+    double minLon;
+    double maxLon;
+
+    double squaredDistanceTo(double lat, double lon) const;
+    bool intersects(const TileBounds& other) const;
+};
+
+struct TileSplit {
+    qint32 axis;
+    double value;
+    qint32 left;
+    qint32 right;
+};
+
+struct TileLayout {
+    TileBounds bounds;
+    qint32 root;
+    QVector<TileSplit> splits;
+    QVector<TileBounds> cellBounds;
+
+    static bool isCell(qint32 child);
+    static int cellOf(qint32 child);
+    static qint32 childOfCell(int cell);
+
+    int cellAt(double lat, double lon) const;
+    QVector<int> cellsInRange(const TileBounds& range) const;
+    TileBounds childBounds(const TileBounds& parent, const TileSplit& split, bool left) const;
+};
+
+QDataStream& operator<<(QDataStream& out, const TileBounds& bounds);
+QDataStream& operator>>(QDataStream& in, TileBounds& bounds);
+QDataStream& operator<<(QDataStream& out, const TileSplit& split);
+QDataStream& operator>>(QDataStream& in, TileSplit& split);
+
+class TileCell {
+public:
+    TileCell();
+    ~TileCell();
+    bool load(const QString& filename, int expectedNodes, int cellCount);
+    int getNodeCount() const;
+    const TileNodeRecord& getNode(int index) const;
+    int findNode(int id) const;
+    const TileEdgeRecord* edgesBegin(int index) const;
+    const TileEdgeRecord* edgesEnd(int index) const;
+    qint64 getByteSize() const;
+
+private:
+    QFile file;
+    QByteArray buffer;
+    const uchar* data;
+    qint64 size;
+    const TileCellHeader* header;
+    const TileNodeRecord* nodes;
+    const TileEdgeRecord* edges;
+};
+
+class TileStore {
+public:
+    static constexpr quint32 cellMagic = 0x4C454354;
+    static constexpr qint32 cellVersion = 2;
+    static constexpr quint32 indexMagic = 0x58444954;
+    static constexpr qint32 indexVersion = 2;
+
+    explicit TileStore(int maxResidentCells = 32);
+    bool open(const QString& directory);
+    std::shared_ptr<TileCell> getCell(int cell);
+    int getCellAt(double lat, double lon) const;
+    QVector<int> getCellsInRange(double minLat, double maxLat, double minLon, double maxLon) const;
+    bool findNearest(double lat, double lon, GraphNode& node, int& cell);
+    QVector<GraphNode> dijkstra(int start, int startCell, int end, int endCell);
+    const TileLayout& getLayout() const;
+    int getCellCount() const;
+    int getMaxResidentCells() const;
+    int getResidentCellCount() const;
+    int getCellLoadCount() const;
+    qint64 getMappedBytes() const;
+    qint64 getPeakMappedBytes() const;
+    qint64 getLastSearchBytes() const;
+    qint64 getMapBytes() const;
+    const QString& getLoadError() const;
+
+    static QString cellFileName(const QString& directory, int cell);
+    static QString indexFileName(const QString& directory);
+
+private:
+    QString directory;
+    TileLayout layout;
+    QVector<qint64> cellBytes;
+    QVector<qint32> cellNodeCounts;
+    int maxResidentCells;
+    QHash<int, std::shared_ptr<TileCell>> residentCells;
+    QList<int> recentCells;
+    qint64 mappedBytes;
+    qint64 peakMappedBytes;
+    qint64 lastSearchBytes;
+    int cellLoads;
+    QString loadError;
+    void evictUnusedCells();
+    static bool isValidChild(qint32 child, int parent, int splitCount, int cellCount);
+};
+
+#endif
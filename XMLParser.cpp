@@ -7,6 +7,18 @@ XMLParser::XMLParser() {
 }
 
 bool XMLParser::parseFile(const QString& filename) {
+    return streamFile(filename,
+        [this](const Node& node) {
+            nodes[node.id] = node;
+        },
+        [this](const Arc& arc) {
+            arcs.append(arc);
+        });
+}
+
+bool XMLParser::streamFile(const QString& filename,
+                           const std::function<void(const Node&)>& visitNode,
+                           const std::function<void(const Arc&)>& visitArc) {
     QFile file(filename);
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
         return false;
@@ -23,14 +35,14 @@ bool XMLParser::parseFile(const QString& filename) {
                 node.id = xml.attributes().value("id").toInt();
                 node.latitude = xml.attributes().value("latitude").toDouble();
                 node.longitude = xml.attributes().value("longitude").toDouble();
-                nodes[node.id] = node;
+                visitNode(node);
             }
             else if (xml.name() == "arc") {
                 Arc arc;
                 arc.from = xml.attributes().value("from").toInt();
                 arc.to = xml.attributes().value("to").toInt();
                 arc.length = xml.attributes().value("length").toInt();
-                arcs.append(arc);
+                visitArc(arc);
             }
         }
     }
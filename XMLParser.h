@@ -5,6 +5,7 @@
 #include <QMap>
 #include <QVector>
 #include <QPair>
+#include <functional>
 
 struct Node {
     int id;
@@ -25,6 +26,10 @@ public:
     const QMap<int, Node>& getNodes() const;
     const QVector<Arc>& getArcs() const;
 
+    static bool streamFile(const QString& filename,
+                           const std::function<void(const Node&)>& visitNode,
+                           const std::function<void(const Arc&)>& visitArc);
+
 private:
     QMap<int, Node> nodes;
     QVector<Arc> arcs;
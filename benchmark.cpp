@@ -0,0 +1,281 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "XMLParser.h"
+#include "Graph.h"
+#include "MapPartitioner.h"
+#include "TileStore.h"
+
+qint64 residentSetBytes() {
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2) {
+        return -1;
+    }
+    return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+}
+
+qint64 peakResidentSetBytes() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+    return static_cast<qint64>(usage.ru_maxrss) * 1024;
+}
+
+bool readQueries(const QString& queryFilename, QVector<QPair<int, int>>& queries) {
+    QFile queryFile(queryFilename);
+    if (!queryFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&queryFile);
+    qint32 count;
+    in >> count;
+    for (int i = 0; i < count; ++i) {
+        qint32 start, end;
+        double startLat, startLon, endLat, endLon;
+        in >> start >> startLat >> startLon >> end >> endLat >> endLon;
+        queries.append(qMakePair(static_cast<int>(start), static_cast<int>(end)));
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+int runGraphQueries(const QString& filename, const QString& queryFilename, const QString& layoutName) {
+    qint64 baseline = residentSetBytes();
+
+    Graph graph;
+    bool parsed = XMLParser::streamFile(filename,
+        [&](const Node& node) {
+            graph.addNode(node.id, node.latitude, node.longitude);
+        },
+        [&](const Arc& arc) {
+            graph.addEdge(arc.from, arc.to, arc.length);
+        });
+    if (!parsed) {
+        std::cout << "Failed to parse " << filename.toStdString() << std::endl;
+        return 1;
+    }
+
+    Graph::EdgeLayout layout = Graph::AdjacencyEdges;
+    if (layoutName == "packed") layout = Graph::PackedEdges;
+    if (layoutName == "compressed") layout = Graph::CompressedEdges;
+    if (!graph.packEdges(layout)) {
+        std::cout << "Edges do not fit the " << layoutName.toStdString() << " layout" << std::endl;
+        return 1;
+    }
+    qint64 builtBytes = residentSetBytes();
+
+    QVector<QPair<int, int>> queries;
+    if (!readQueries(queryFilename, queries)) {
+        std::cout << "Failed to read queries" << std::endl;
+        return 1;
+    }
+
+    QVector<QVector<int>> paths;
+    auto begin = std::chrono::steady_clock::now();
+    for (const auto& query : queries) {
+        paths.append(graph.dijkstra(query.first, query.second));
+    }
+    auto finish = std::chrono::steady_clock::now();
+    double queryTime = std::chrono::duration<double, std::milli>(finish - begin).count() / std::max(1, queries.size());
+
+    for (const QVector<int>& path : paths) {
+        std::cout << "path";
+        for (int id : path) {
+            std::cout << ' ' << id;
+        }
+        std::cout << '\n';
+    }
+
+    std::cout << layoutName.toStdString() << ": " << graph.getEdgeCount() << " edges, "
+              << static_cast<double>(graph.getEdgeStorageBytes()) / std::max<qint64>(1, graph.getEdgeCount())
+              << " bytes/edge, RSS " << baseline << " before parsing, " << builtBytes << " after build, "
+              << peakResidentSetBytes() << " peak; " << queryTime << " ms/query" << std::endl;
+    return 0;
+}
+
+int runTileQueries(const QString& directory, const QString& queryFilename, int budget) {
+    qint64 baseline = residentSetBytes();
+
+    TileStore tiles(budget);
+    if (!tiles.open(directory)) {
+        std::cout << "Failed to open tiles" << std::endl;
+        return 1;
+    }
+
+    QFile queryFile(queryFilename);
+    if (!queryFile.open(QIODevice::ReadOnly)) {
+        std::cout << "Failed to read queries" << std::endl;
+        return 1;
+    }
+    QDataStream in(&queryFile);
+    qint32 count;
+    in >> count;
+
+    qint64 peakSearchBytes = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i) {
+        qint32 start, end;
+        double startLat, startLon, endLat, endLon;
+        in >> start >> startLat >> startLon >> end >> endLat >> endLon;
+
+        QVector<GraphNode> path = tiles.dijkstra(start, tiles.getCellAt(startLat, startLon),
+                                                 end, tiles.getCellAt(endLat, endLon));
+        if (!tiles.getLoadError().isEmpty()) {
+            std::cout << tiles.getLoadError().toStdString() << std::endl;
+            return 1;
+        }
+        peakSearchBytes = std::max(peakSearchBytes, tiles.getLastSearchBytes());
+
+        std::cout << "path";
+        for (const GraphNode& node : path) {
+            std::cout << ' ' << node.id;
+        }
+        std::cout << '\n';
+    }
+    auto finish = std::chrono::steady_clock::now();
+    double tileTime = std::chrono::duration<double, std::milli>(finish - begin).count() / std::max(1, count);
+
+    std::cout << "Tiles (" << tiles.getCellCount() << " cells, budget " << budget << "): map "
+              << tiles.getMapBytes() << " bytes, RSS " << baseline << " before open, "
+              << residentSetBytes() << " after queries, " << peakResidentSetBytes() << " peak; "
+              << tiles.getPeakMappedBytes() << " bytes mapped at peak, "
+              << peakSearchBytes << " bytes peak search state, "
+              << tiles.getCellLoadCount() << " cell loads, " << tileTime << " ms/query" << std::endl;
+    return 0;
+}
+
+bool runChild(const QStringList& arguments, const Graph& graph, QVector<double>& lengths) {
+    QProcess child;
+    child.start(QCoreApplication::applicationFilePath(), arguments);
+    if (!child.waitForFinished(-1) || child.exitStatus() != QProcess::NormalExit || child.exitCode() != 0) {
+        std::cout << child.readAllStandardOutput().toStdString();
+        return false;
+    }
+
+    lengths.clear();
+    for (const QByteArray& line : child.readAllStandardOutput().split('\n')) {
+        if (!line.startsWith("path")) {
+            if (!line.isEmpty()) std::cout << line.toStdString() << std::endl;
+            continue;
+        }
+        QVector<int> path;
+        for (const QByteArray& id : line.mid(4).split(' ')) {
+            if (!id.isEmpty()) path.append(id.toInt());
+        }
+        lengths.append(graph.calculatePathLength(path));
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    if (argc == 5 && QString(argv[1]) == "--tiles") {
+        return runTileQueries(argv[2], argv[3], std::atoi(argv[4]));
+    }
+    if (argc == 5 && QString(argv[1]) == "--graph") {
+        return runGraphQueries(argv[2], argv[3], argv[4]);
+    }
+
+    QString filename = argc > 1 ? argv[1] : "Harta_Luxemburg.xml";
+    int queryCount = argc > 2 ? std::atoi(argv[2]) : 100;
+    int nodesPerCell = argc > 3 ? std::atoi(argv[3]) : 2000;
+
+    Graph graph;
+    bool parsed = XMLParser::streamFile(filename,
+        [&](const Node& node) {
+            graph.addNode(node.id, node.latitude, node.longitude);
+        },
+        [&](const Arc& arc) {
+            graph.addEdge(arc.from, arc.to, arc.length);
+        });
+    if (!parsed) {
+        std::cout << "Failed to parse " << filename.toStdString() << std::endl;
+        return 1;
+    }
+
+    const QMap<int, GraphNode>& nodes = graph.getNodes();
+    QVector<int> ids = nodes.keys().toVector();
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> pick(0, ids.size() - 1);
+    QVector<QPair<int, int>> queries;
+    for (int i = 0; i < queryCount; ++i) {
+        queries.append(qMakePair(ids[pick(rng)], ids[pick(rng)]));
+    }
+
+    std::cout << "Graph: " << nodes.size() << " nodes, " << graph.getEdgeCount() << " arcs, "
+              << queries.size() << " queries" << std::endl;
+
+    QTemporaryDir workDirectory;
+    if (!workDirectory.isValid()) {
+        std::cout << "Failed to create a temporary directory" << std::endl;
+        return 1;
+    }
+    QString queryFilename = QDir(workDirectory.path()).filePath("queries.bin");
+    QFile queryFile(queryFilename);
+    if (!queryFile.open(QIODevice::WriteOnly)) {
+        std::cout << "Failed to write queries" << std::endl;
+        return 1;
+    }
+    QDataStream out(&queryFile);
+    out << static_cast<qint32>(queries.size());
+    for (const auto& query : queries) {
+        const GraphNode& from = nodes[query.first];
+        const GraphNode& to = nodes[query.second];
+        out << static_cast<qint32>(from.id) << from.latitude << from.longitude
+            << static_cast<qint32>(to.id) << to.latitude << to.longitude;
+    }
+    queryFile.close();
+
+    QVector<double> referenceLengths;
+    for (const QString& layout : {QString("adjacency"), QString("packed"), QString("compressed")}) {
+        QVector<double> lengths;
+        if (!runChild(QStringList() << "--graph" << filename << queryFilename << layout, graph, lengths)) {
+            std::cout << "Graph benchmark process failed for the " << layout.toStdString() << " layout" << std::endl;
+            return 1;
+        }
+        if (referenceLengths.isEmpty()) {
+            referenceLengths = lengths;
+        }
+        if (lengths.size() != queries.size() || lengths != referenceLengths) {
+            std::cout << "Path lengths of the " << layout.toStdString() << " layout differ from the adjacency list" << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "Path lengths match across edge layouts on all queries" << std::endl;
+
+    QString tileDirectory = QDir(workDirectory.path()).filePath("tiles");
+    MapPartitioner partitioner;
+    if (!partitioner.partition(filename, tileDirectory, nodesPerCell)) {
+        std::cout << "Failed to write tiles" << std::endl;
+        return 1;
+    }
+
+    for (int budget : {4, 16, 64}) {
+        QVector<double> tileLengths;
+        if (!runChild(QStringList() << "--tiles" << tileDirectory << queryFilename << QString::number(budget), graph, tileLengths)) {
+            std::cout << "Tile benchmark process failed" << std::endl;
+            return 1;
+        }
+        if (tileLengths != referenceLengths) {
+            std::cout << "Tiled and whole-graph path lengths differ" << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "Tiled path lengths match whole-graph Dijkstra on all queries" << std::endl;
+
+    return 0;
+}
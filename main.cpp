@@ -4,35 +4,86 @@
 #include "XMLParser.h"
 #include "Graph.h"
 #include "KDTree.h"
+#include "MapPartitioner.h"
+#include "TileStore.h"
+
+QString argumentValue(const QStringList& arguments, const QString& name) {
+    int index = arguments.indexOf(name);
+    if (index == -1 || index + 1 >= arguments.size()) {
+        return QString();
+    }
+    return arguments[index + 1];
+}
 
 int main(int argc, char* argv[]) {
     QApplication app(argc, argv);
     
-    XMLParser parser;
-    if (!parser.parseFile("Harta_Luxemburg.xml")) {
-        qDebug() << "Failed to parse XML file";
-        return 1;
+    QString mapFilename = argumentValue(app.arguments(), "--map");
+    if (mapFilename.isEmpty()) {
+        mapFilename = "Harta_Luxemburg.xml";
     }
     
-    const QMap<int, Node>& nodes = parser.getNodes();
-    const QVector<Arc>& arcs = parser.getArcs();
+    QString tileDirectory = argumentValue(app.arguments(), "--tiles");
+    if (!tileDirectory.isEmpty()) {
+        int residentCells = argumentValue(app.arguments(), "--resident-cells").toInt();
+        TileStore tiles(residentCells > 0 ? residentCells : 32);
+        if (!tiles.open(tileDirectory)) {
+            qDebug() << "Failed to open tiles in" << tileDirectory;
+            return 1;
+        }
+        
+        qDebug() << "Opened" << tiles.getCellCount() << "cells," << tiles.getMapBytes() << "bytes on disk";
+        
+        MainWindow window(&tiles);
+        window.show();
+        
+        return app.exec();
+    }
     
-    qDebug() << "Loaded" << nodes.size() << "nodes and" << arcs.size() << "arcs";
+    QString partitionDirectory = argumentValue(app.arguments(), "--partition");
+    if (!partitionDirectory.isEmpty()) {
+        MapPartitioner partitioner;
+        int nodesPerCell = argumentValue(app.arguments(), "--cell-nodes").toInt();
+        if (!partitioner.partition(mapFilename, partitionDirectory, nodesPerCell > 0 ? nodesPerCell : 2000)) {
+            qDebug() << "Failed to write tiles to" << partitionDirectory;
+            return 1;
+        }
+        
+        qDebug() << "Wrote" << partitioner.getLayout().cellBounds.size() << "cells to" << partitionDirectory;
+        return 0;
+    }
     
     Graph graph;
-    for (auto it = nodes.begin(); it != nodes.end(); ++it) {
-        const Node& node = it.value();
-        graph.addNode(node.id, node.latitude, node.longitude);
+    int arcCount = 0;
+    bool parsed = XMLParser::streamFile(mapFilename,
+        [&](const Node& node) {
+            graph.addNode(node.id, node.latitude, node.longitude);
+        },
+        [&](const Arc& arc) {
+            graph.addEdge(arc.from, arc.to, arc.length);
+            ++arcCount;
+        });
+    if (!parsed) {
+        qDebug() << "Failed to parse" << mapFilename;
+        return 1;
     }
     
-    for (const Arc& arc : arcs) {
-        graph.addEdge(arc.from, arc.to, arc.length);
+    const QMap<int, GraphNode>& nodes = graph.getNodes();
+    
+    qDebug() << "Loaded" << nodes.size() << "nodes and" << arcCount << "arcs";
+    
+    if (app.arguments().contains("--compressed")) {
+        if (graph.packEdges(Graph::CompressedEdges)) {
+            qDebug() << "Edges compressed to" << graph.getEdgeStorageBytes() << "bytes";
+        } else {
+            qDebug() << "Edge weights are not integral, keeping uncompressed edges";
+        }
     }
     
     QVector<QPair<double, double>> points;
     QVector<int> ids;
     for (auto it = nodes.begin(); it != nodes.end(); ++it) {
-        const Node& node = it.value();
+        const GraphNode& node = it.value();
         points.append(qMakePair(node.latitude, node.longitude));
         ids.append(node.id);
     }
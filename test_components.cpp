@@ -1,8 +1,12 @@
 #include <iostream>
 #include <algorithm>
+#include <random>
 #include "XMLParser.h"
 #include "Graph.h"
 #include "KDTree.h"
+#include "MapPartitioner.h"
+#include "TileStore.h"
+#include <QTemporaryDir>
 
 int main() {
     std::cout << "Testing Dijkstra Path Visualizer Components..." << std::endl;
@@ -85,11 +89,134 @@ int main() {
         std::cout << std::endl;
     }
     
+    std::cout << "6. Testing packed and compressed edge storage..." << std::endl;
+    for (Graph::EdgeLayout layout : {Graph::PackedEdges, Graph::CompressedEdges}) {
+        Graph small;
+        small.addNode(10, 49.60, 6.10);
+        small.addNode(20, 49.50, 6.00);
+        small.addNode(30, 49.70, 6.20);
+        small.addNode(40, 49.80, 6.30);
+        small.addNode(50, 49.90, 6.40);
+        small.addEdge(10, 20, 5);
+        small.addEdge(10, 20, 3);
+        small.addEdge(20, 10, 3);
+        small.addEdge(20, 30, 4);
+        small.addEdge(10, 30, 10);
+        small.addEdge(30, 40, 1);
+        small.addEdge(40, 60, 1);
+        if (!small.packEdges(layout) || small.getEdgeLayout() != layout || small.getEdgeCount() != 6) {
+            std::cout << "   [FAIL] Packing the hand-built graph failed" << std::endl;
+            return 1;
+        }
+        if (small.dijkstra(10, 40) != QVector<int>({10, 20, 30, 40}) ||
+            small.calculatePathLength(small.dijkstra(10, 40)) != 8 ||
+            small.dijkstra(20, 10) != QVector<int>({20, 10}) ||
+            small.dijkstra(30, 30) != QVector<int>({30}) ||
+            !small.dijkstra(10, 50).isEmpty() ||
+            !small.dijkstra(10, 60).isEmpty()) {
+            std::cout << "   [FAIL] Packed Dijkstra returned a wrong path on the hand-built graph" << std::endl;
+            return 1;
+        }
+        small.addEdge(40, 50, 2);
+        if (small.getEdgeLayout() != Graph::AdjacencyEdges || small.getEdgeCount() != 7 ||
+            small.calculatePathLength(small.dijkstra(10, 50)) != 10 ||
+            small.calculatePathLength(small.dijkstra(10, 20)) != 3) {
+            std::cout << "   [FAIL] Adding an edge after packing lost edges" << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "   [PASS] Hand-built graph routes match in both packed layouts" << std::endl;
+    
+    double uncompressedLength = graph.calculatePathLength(path);
+    qint64 uncompressedBytes = graph.getEdgeStorageBytes();
+    if (!graph.packEdges(Graph::CompressedEdges)) {
+        std::cout << "   [FAIL] Edge compression failed" << std::endl;
+        return 1;
+    }
+    QVector<int> compressedPath = graph.dijkstra(startNode, endNode);
+    if (compressedPath.isEmpty() != path.isEmpty() ||
+        graph.calculatePathLength(compressedPath) != uncompressedLength) {
+        std::cout << "   [FAIL] Compressed Dijkstra disagrees with uncompressed result" << std::endl;
+        return 1;
+    }
+    std::cout << "   [PASS] Edge storage reduced from " << uncompressedBytes << " to "
+              << graph.getEdgeStorageBytes() << " bytes" << std::endl;
+    
+    std::cout << "7. Testing partitioned tiles..." << std::endl;
+    QTemporaryDir tileDirectory;
+    MapPartitioner partitioner;
+    if (!tileDirectory.isValid() || !partitioner.partition("Harta_Luxemburg.xml", tileDirectory.path(), 500)) {
+        std::cout << "   [FAIL] Failed to write tiles" << std::endl;
+        return 1;
+    }
+    TileStore tiles(8);
+    if (!tiles.open(tileDirectory.path())) {
+        std::cout << "   [FAIL] Failed to open tiles" << std::endl;
+        return 1;
+    }
+    const Node& tileStart = nodes[startNode];
+    const Node& tileEnd = nodes[endNode];
+    QVector<int> tilePath;
+    for (const GraphNode& node : tiles.dijkstra(startNode, tiles.getCellAt(tileStart.latitude, tileStart.longitude),
+                                                endNode, tiles.getCellAt(tileEnd.latitude, tileEnd.longitude))) {
+        tilePath.append(node.id);
+    }
+    if (!tiles.getLoadError().isEmpty()) {
+        std::cout << "   [FAIL] " << tiles.getLoadError().toStdString() << std::endl;
+        return 1;
+    }
+    if (tilePath.isEmpty() != path.isEmpty() || graph.calculatePathLength(tilePath) != uncompressedLength) {
+        std::cout << "   [FAIL] Tiled Dijkstra disagrees with whole-graph result" << std::endl;
+        return 1;
+    }
+    if (tiles.getResidentCellCount() > 8) {
+        std::cout << "   [FAIL] Resident cells exceed budget" << std::endl;
+        return 1;
+    }
+    std::cout << "   [PASS] " << tiles.getCellCount() << " cells, " << tiles.getMappedBytes() << " of "
+              << tiles.getMapBytes() << " bytes mapped" << std::endl;
+    
+    TileStore smallTiles(2);
+    if (!smallTiles.open(tileDirectory.path())) {
+        std::cout << "   [FAIL] Failed to open tiles" << std::endl;
+        return 1;
+    }
+    QVector<int> nodeIds = nodes.keys().toVector();
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> pick(0, nodeIds.size() - 1);
+    for (int i = 0; i < 20; ++i) {
+        const Node& from = nodes[nodeIds[pick(rng)]];
+        const Node& to = nodes[nodeIds[pick(rng)]];
+        QVector<int> queryPath;
+        for (const GraphNode& node : smallTiles.dijkstra(from.id, smallTiles.getCellAt(from.latitude, from.longitude),
+                                                         to.id, smallTiles.getCellAt(to.latitude, to.longitude))) {
+            queryPath.append(node.id);
+        }
+        if (!smallTiles.getLoadError().isEmpty()) {
+            std::cout << "   [FAIL] " << smallTiles.getLoadError().toStdString() << std::endl;
+            return 1;
+        }
+        QVector<int> wholePath = graph.dijkstra(from.id, to.id);
+        if (queryPath.isEmpty() != wholePath.isEmpty() ||
+            graph.calculatePathLength(queryPath) != graph.calculatePathLength(wholePath)) {
+            std::cout << "   [FAIL] Tiled Dijkstra with 2 resident cells disagrees with whole-graph result" << std::endl;
+            return 1;
+        }
+        if (smallTiles.getResidentCellCount() > 2) {
+            std::cout << "   [FAIL] Resident cells exceed budget of 2" << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "   [PASS] 20 queries with 2 resident cells, " << smallTiles.getCellLoadCount()
+              << " cell loads" << std::endl;
+    
     std::cout << "\nAll core components tested successfully!" << std::endl;
     std::cout << "\nApplication Features:" << std::endl;
     std::cout << "- XML parsing with QXmlStreamReader" << std::endl;
     std::cout << "- Graph data structure with adjacency list" << std::endl;
     std::cout << "- Dijkstra's algorithm with priority queue" << std::endl;
+    std::cout << "- Delta and varint compressed edge storage" << std::endl;
+    std::cout << "- Partitioned map tiles loaded on demand" << std::endl;
     std::cout << "- K-d tree for efficient spatial queries" << std::endl;
     std::cout << "- Qt GUI with mouse interaction and zoom" << std::endl;
     std::cout << "- Visual shortest path display" << std::endl;